@@ -0,0 +1,163 @@
+// Throughput of independent reader contexts running in parallel threads.
+// Each thread parses its own copy of the same buffer with its own context,
+// so aggregate MB/s should grow with the thread count up to the core count.
+// CPU seconds staying flat per unit of work means threads do not contend.
+//
+// Build and run from the repository root:
+//   gcc -O2 -pthread -o threadBench bench/threadBench.c
+//   ./threadBench [buffer-KiB [rounds [threads...]]]
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// Pull in the reader itself, without its command line entry point
+#define main readerMain
+#include "../main.c"
+#undef main
+
+struct Job
+{
+    char *buffer;  // this thread's own copy of the source
+    size_t length; // length of buffer
+    int rounds;    // times to parse the buffer
+    long forms;    // forms read over all rounds
+    int status;    // first status other than CONTEXT_OK / CONTEXT_END
+};
+
+// Fill a buffer with a mix of the forms config and rule files are made of
+char *makeBuffer(size_t size, size_t *length)
+{
+    char *buffer = malloc(size + 256);
+    size_t used = 0;
+
+    for (int i = 0; used < size; i++)
+    {
+        used += snprintf(buffer + used, 256,
+                         "(define (rule%d x y) (let ((a (plus x %d)) (b \"name %d\")) (when (lt a %d.5e-3) (list a b y))))\n"
+                         "(config%d #{id %d weight %.17g tags (a b c) label \"item\"})\n",
+                         i, i, i, i, i % 97, i, i * 0.1);
+    }
+
+    *length = used;
+    return buffer;
+}
+
+void *runJob(void *argument)
+{
+    struct Job *job = argument;
+
+    for (int round = 0; round < job->rounds; round++)
+    {
+        struct Context *context = createContext();
+        int status = contextParse(context, job->buffer, job->length);
+
+        struct SExpr *form;
+        while (status != CONTEXT_END && status != CONTEXT_OUT_OF_MEMORY)
+        {
+            status = contextNextForm(context, &form);
+            job->forms += status == CONTEXT_OK;
+
+            if (status != CONTEXT_OK && status != CONTEXT_END && job->status == CONTEXT_OK)
+            {
+                job->status = status;
+            }
+        }
+
+        destroyContext(context);
+    }
+
+    return NULL;
+}
+
+double now(clockid_t clock)
+{
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t size = (argc > 1 ? atoi(argv[1]) : 1024) * 1024;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    int defaultThreads[] = {1, 2, 4, 8, 16};
+    int threadCounts[16];
+    int runCount = 0;
+
+    for (int i = 3; i < argc && runCount < 16; i++)
+    {
+        threadCounts[runCount++] = atoi(argv[i]);
+    }
+
+    if (runCount == 0)
+    {
+        memcpy(threadCounts, defaultThreads, sizeof(defaultThreads));
+        runCount = sizeof(defaultThreads) / sizeof(defaultThreads[0]);
+    }
+
+    size_t length;
+    char *source = makeBuffer(size, &length);
+
+    printf("buffer %.1f MiB, %d rounds per thread, %ld cores online\n",
+           length / (1024.0 * 1024.0), rounds, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("threads  seconds  cpu seconds  MB/s total  MB/s per thread  speedup\n");
+
+    double baseline = 0;
+
+    for (int run = 0; run < runCount; run++)
+    {
+        int threadCount = threadCounts[run];
+        pthread_t *threads = malloc(sizeof(pthread_t) * threadCount);
+        struct Job *jobs = calloc(threadCount, sizeof(struct Job));
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            jobs[i].buffer = malloc(length + 1);
+            memcpy(jobs[i].buffer, source, length + 1);
+            jobs[i].length = length;
+            jobs[i].rounds = rounds;
+        }
+
+        double start = now(CLOCK_MONOTONIC);
+        double cpuStart = now(CLOCK_PROCESS_CPUTIME_ID);
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            pthread_create(&threads[i], NULL, runJob, &jobs[i]);
+        }
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        double seconds = now(CLOCK_MONOTONIC) - start;
+        double cpuSeconds = now(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            if (jobs[i].status != CONTEXT_OK || jobs[i].forms != jobs[0].forms)
+            {
+                printf("thread %d: status %d after %ld forms\n", i, jobs[i].status, jobs[i].forms);
+                return 1;
+            }
+
+            free(jobs[i].buffer);
+        }
+
+        double throughput = (double)length * rounds * threadCount / seconds / 1e6;
+        baseline = run == 0 ? throughput / threadCount : baseline;
+
+        printf("%7d  %7.2f  %11.2f  %10.1f  %15.1f  %6.2fx\n",
+               threadCount, seconds, cpuSeconds, throughput, throughput / threadCount, throughput / baseline);
+
+        free(threads);
+        free(jobs);
+    }
+
+    free(source);
+
+    return 0;
+}
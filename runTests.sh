@@ -7,11 +7,12 @@ gcc -o main main.c
 RESOURCE_DIR_IN="./resources/sprint1/input"
 RESOURCE_DIR_EX="./resources/sprint1/expected"
 RESOURCE_DIR_OUT="./resources/sprint1/output"
+RESOURCE_DIR_ARGS="./resources/sprint1/args"
 
 # File to store the final test report
 REPORT_FILE="./resources/sprint1/test_report.txt"
 
-TOTAL=20
+TOTAL=27
 PASS=0
 
 # Clear previous report
@@ -22,12 +23,19 @@ for i in $(seq 1 $TOTAL); do
     INPUT="$RESOURCE_DIR_IN/tc${i}.txt"
     EXPECTED="$RESOURCE_DIR_EX/tc${i}.txt"
     OUTPUT="$RESOURCE_DIR_OUT/tc${i}.txt"
+    ARGS_FILE="$RESOURCE_DIR_ARGS/tc${i}.txt"
+
+    # Extra arguments after the input file (e.g. a query), if the test has any
+    ARGS=()
+    if [ -f "$ARGS_FILE" ]; then
+        read -r -a ARGS < "$ARGS_FILE"
+    fi
 
     echo "============================" >> "$REPORT_FILE"
     echo "Running test $i..." >> "$REPORT_FILE"
 
     # Run program and capture output
-    ./main "$INPUT" 2>&1 > "$OUTPUT"
+    ./main "$INPUT" "${ARGS[@]}" 2>&1 > "$OUTPUT"
 
     if [ ! -f "$EXPECTED" ]; then
         echo "⚠️ Expected file $EXPECTED not found. Skipping test $i." >> "$REPORT_FILE"
@@ -41,6 +49,10 @@ for i in $(seq 1 $TOTAL); do
     cat "$INPUT" >> "$REPORT_FILE"
     echo >> "$REPORT_FILE"
 
+    if [ ${#ARGS[@]} -gt 0 ]; then
+        echo "Args: ${ARGS[*]}" >> "$REPORT_FILE"
+    fi
+
     echo "Expected:" >> "$REPORT_FILE"
     echo "$EXPECTED_CONTENT" >> "$REPORT_FILE"
 
@@ -56,5 +68,15 @@ for i in $(seq 1 $TOTAL); do
     echo >> "$REPORT_FILE"
 done
 
+# Library API tests (documents, macros, contexts)
+gcc -o apiTests tests/apiTests.c
+
+echo "============================" >> "$REPORT_FILE"
+echo "Running API tests..." >> "$REPORT_FILE"
+API_RESULT=$(./apiTests 2>&1)
+echo "$API_RESULT" >> "$REPORT_FILE"
+echo >> "$REPORT_FILE"
+
 echo "==== Summary ====" >> "$REPORT_FILE"
 echo "Passed $PASS out of $TOTAL tests" >> "$REPORT_FILE"
+echo "$API_RESULT" | tail -n 1 >> "$REPORT_FILE"
@@ -0,0 +1,532 @@
+// Tests of the library API that the tc files cannot reach from the command
+// line: incremental documents, macro expansion and contexts.
+//
+// Build and run from the repository root (runTests.sh does both):
+//   gcc -o apiTests tests/apiTests.c && ./apiTests
+
+// Pull in the reader itself, without its command line entry point
+#define main readerMain
+#include "../main.c"
+#undef main
+
+int checkCount = 0;
+int failureCount = 0;
+
+// Record one check; a failed one is printed with the test it belongs to
+void check(bool condition, const char *test, const char *description)
+{
+    checkCount++;
+
+    if (!condition)
+    {
+        failureCount++;
+        printf("FAILED %s: %s\n", test, description);
+    }
+}
+
+// Structural equality of two trees from the same context, hash tables included
+bool isSameForm(struct SExpr *a, struct SExpr *b)
+{
+    if (a == b)
+    {
+        return true;
+    }
+
+    if (a == NULL || b == NULL || a->type != b->type)
+    {
+        return false;
+    }
+
+    if (a->type == TYPE_CONS)
+    {
+        return isSameForm(a->cons.car, b->cons.car) && isSameForm(a->cons.cdr, b->cons.cdr);
+    }
+
+    if (a->type != TYPE_HASH_TABLE)
+    {
+        return isSameTree(a, b);
+    }
+
+    if (hashTableSize(a) != hashTableSize(b))
+    {
+        return false;
+    }
+
+    int positionA = 0;
+    int positionB = 0;
+    struct SExpr *keyA, *valueA, *keyB, *valueB;
+
+    while (hashTableNext(a, &positionA, &keyA, &valueA))
+    {
+        hashTableNext(b, &positionB, &keyB, &valueB);
+
+        if (!isSameForm(keyA, keyB) || !isSameForm(valueA, valueB))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// An edited document must hold what parsing its text from scratch gives
+bool isSameDocument(struct Document *edited, struct Document *fresh)
+{
+    if (edited->formCount != fresh->formCount ||
+        edited->scanner.tokenCount != fresh->scanner.tokenCount)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < edited->formCount; i++)
+    {
+        struct Form a = edited->forms[i];
+        struct Form b = fresh->forms[i];
+
+        if (a.firstToken != b.firstToken || a.tokenCount != b.tokenCount ||
+            (a.error == NULL) != (b.error == NULL) ||
+            (a.error != NULL && strcmp(a.error, b.error) != 0) ||
+            !isSameForm(a.sexpr, b.sexpr))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// First form of text, parsed in context
+struct SExpr *parseText(struct Context *context, const char *text)
+{
+    struct SExpr *form = NULL;
+    contextParse(context, text, strlen(text));
+    contextNextForm(context, &form);
+
+    return form;
+}
+
+// Expand the first form of text, NULL if expansion fails
+struct SExpr *expandText(struct Expander *expander, const char *text)
+{
+    struct SExpr *expanded = NULL;
+    int status = contextExpandForm(expander, parseText(expander->context, text), &expanded);
+
+    return status == CONTEXT_OK ? expanded : NULL;
+}
+
+// Incremental Related
+void testEditsMatchFreshParse()
+{
+    const char *pieces[] = {"(", ")", " \"s t\" ", "\n", " 12 ", " foo", " nil ", " 1.", " 1e", " -", " #{a 1}", " . ", " x"};
+    const char *insertable = "ab1 \n9ze.-+()#{}";
+    int pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+
+    srand(1);
+    int mismatches = 0;
+
+    for (int round = 0; round < 200; round++)
+    {
+        struct Context *context = createContext();
+
+        // Random forms, mostly balanced
+        char source[512];
+        int length = 0;
+        int depth = 0;
+
+        while (length < 300)
+        {
+            int piece = rand() % pieceCount;
+            if (piece == 1 && depth == 0)
+            {
+                piece = 0;
+            }
+
+            depth += piece == 0 ? 1 : piece == 1 ? -1 : 0;
+            length += sprintf(source + length, "%s", pieces[piece]);
+        }
+
+        while (depth-- > 0)
+        {
+            source[length++] = ')';
+        }
+        source[length] = '\0';
+
+        struct Document document;
+        openDocument(context, strdup(source), &document);
+
+        for (int edit = 0; edit < 20; edit++)
+        {
+            const char *text = document.scanner.source;
+            int textLength = document.scanner.sourceLength;
+
+            // Delete up to three characters and insert up to two, outside strings
+            int offset = rand() % (textLength + 1);
+            bool isInString = false;
+            for (int i = 0; i < offset; i++)
+            {
+                isInString ^= text[i] == '"';
+            }
+
+            if (isInString)
+            {
+                continue;
+            }
+
+            int deletedLength = 0;
+            while (offset + deletedLength < textLength && deletedLength < 3 &&
+                   text[offset + deletedLength] != '"' && rand() % 2)
+            {
+                deletedLength++;
+            }
+
+            char inserted[3] = {0};
+            for (int i = rand() % 3; i > 0; i--)
+            {
+                inserted[i - 1] = insertable[rand() % strlen(insertable)];
+            }
+
+            editDocument(&document, offset, deletedLength, inserted);
+
+            struct Document fresh;
+            openDocument(context, strdup(document.scanner.source), &fresh);
+            mismatches += !isSameDocument(&document, &fresh);
+            closeDocument(&fresh);
+        }
+
+        closeDocument(&document);
+        destroyContext(context);
+    }
+
+    check(mismatches == 0, "editsMatchFreshParse", "edited documents equal a fresh parse of their text");
+}
+
+void testInvalidEdit()
+{
+    const char *test = "invalidEdit";
+    struct Context *context = createContext();
+    struct Document document;
+    openDocument(context, strdup("(a b) (c d)"), &document);
+
+    struct SExpr *first = document.forms[0].sexpr;
+
+    check(editDocument(&document, 12, 0, "x") == CONTEXT_INVALID_EDIT, test, "offset past the end is rejected");
+    check(editDocument(&document, 10, 2, "") == CONTEXT_INVALID_EDIT, test, "range past the end is rejected");
+    check(editDocument(&document, -1, 0, "x") == CONTEXT_INVALID_EDIT, test, "negative offset is rejected");
+    check(strcmp(document.scanner.source, "(a b) (c d)") == 0, test, "source is unchanged");
+    check(document.formCount == 2 && document.forms[0].sexpr == first, test, "forms are unchanged");
+
+    check(editDocument(&document, 11, 0, " (e)") == CONTEXT_OK, test, "insertion at the end is accepted");
+    check(document.formCount == 3 && document.forms[0].sexpr == first, test, "insertion at the end keeps earlier forms");
+
+    closeDocument(&document);
+    destroyContext(context);
+}
+
+void testEmptyDocument()
+{
+    const char *test = "emptyDocument";
+    struct Context *context = createContext();
+    struct Document document;
+
+    check(openDocument(context, strdup(""), &document) == CONTEXT_OK, test, "empty source opens");
+    check(document.formCount == 0, test, "empty source has no forms");
+
+    check(editDocument(&document, 0, 0, "") == CONTEXT_OK && document.formCount == 0, test, "empty edit of an empty document");
+    check(editDocument(&document, 0, 0, "(a b)") == CONTEXT_OK && document.formCount == 1, test, "insertion into an empty document");
+    check(editDocument(&document, 0, 5, "") == CONTEXT_OK && document.formCount == 0, test, "deleting everything leaves no forms");
+    check(editDocument(&document, 0, 0, "  \n ") == CONTEXT_OK && document.formCount == 0, test, "whitespace only has no forms");
+
+    closeDocument(&document);
+    destroyContext(context);
+}
+
+void testMalformedForm()
+{
+    const char *test = "malformedForm";
+    struct Context *context = createContext();
+    struct Document document;
+    openDocument(context, strdup("(a) (b (c) (d)"), &document);
+
+    check(document.formCount == 2 && document.forms[1].error != NULL, test, "unclosed list is recorded in its form");
+    check(document.forms[0].error == NULL && document.forms[0].sexpr != NULL, test, "form before it still parses");
+
+    editDocument(&document, 14, 0, ")");
+    check(document.formCount == 2 && document.forms[1].error == NULL, test, "closing the list repairs the form");
+    check(listLength(document.forms[1].sexpr) == 3, test, "repaired form holds its elements");
+
+    closeDocument(&document);
+    destroyContext(context);
+}
+
+// Macro Related
+void testExpansionCache()
+{
+    const char *test = "expansionCache";
+    struct Context *context = createContext();
+    struct Expander expander = createExpander(context);
+
+    expandText(&expander, "(defmacro twice (x) (list x x))");
+
+    struct SExpr *form = parseText(context, "(f (twice a) g (twice (b c)))");
+    struct SExpr *expanded;
+    contextExpandForm(&expander, form, &expanded);
+
+    check(isSameTree(expanded, parseText(context, "(f (list a a) g (list (b c) (b c)))")), test, "macro uses are expanded in subforms");
+    check(listNth(expanded, 2) == listNth(form, 2), test, "unexpanded elements are shared with the source");
+
+    struct SExpr *again;
+    contextExpandForm(&expander, form, &again);
+    check(again == expanded, test, "expanding the same node again returns the cached expansion");
+
+    expander.isCaching = false;
+    contextExpandForm(&expander, form, &again);
+    check(again != expanded && isSameTree(again, expanded), test, "without the cache the expansion is rebuilt");
+
+    freeExpander(&expander);
+    destroyContext(context);
+}
+
+void testRedefinition()
+{
+    const char *test = "redefinition";
+    struct Context *context = createContext();
+    struct Expander expander = createExpander(context);
+
+    expandText(&expander, "(defmacro twice (x) (list x x))");
+
+    struct SExpr *form = parseText(context, "(twice a)");
+    struct SExpr *first;
+    contextExpandForm(&expander, form, &first);
+
+    expandText(&expander, "(defmacro twice (x) (list x x))");
+    struct SExpr *same;
+    contextExpandForm(&expander, form, &same);
+    check(same == first && expander.macroCount == 1, test, "the same definition again keeps the cache");
+
+    expandText(&expander, "(defmacro twice (x) (pair x x))");
+    struct SExpr *changed;
+    contextExpandForm(&expander, form, &changed);
+    check(isSameTree(changed, parseText(context, "(pair a a)")), test, "a new definition replaces the old one");
+    check(expander.macroCount == 1, test, "a redefined macro is not added twice");
+
+    expandText(&expander, "(defmacro call (f . arguments) (apply f arguments))");
+    check(isSameTree(expandText(&expander, "(call g 1 \"two\" 3.5)"), parseText(context, "(apply g (1 \"two\" 3.5))")),
+          test, "a dotted rest parameter takes the remaining arguments");
+
+    freeExpander(&expander);
+    destroyContext(context);
+}
+
+void testMacroErrors()
+{
+    const char *test = "macroErrors";
+    struct Context *context = createContext();
+    struct Expander expander = createExpander(context);
+    struct SExpr *expanded;
+
+    check(contextExpandForm(&expander, parseText(context, "(defmacro broken x)"), &expanded) == CONTEXT_MACRO_ERROR,
+          test, "a malformed definition is an error");
+
+    expandText(&expander, "(defmacro forever (x) (forever x))");
+    check(contextExpandForm(&expander, parseText(context, "(forever 1)"), &expanded) == CONTEXT_MACRO_ERROR,
+          test, "an expansion that does not terminate is an error");
+
+    expandText(&expander, "(defmacro deeper (x) (wrap (deeper x)))");
+    check(contextExpandForm(&expander, parseText(context, "(a (b (deeper 1)))"), &expanded) == CONTEXT_MACRO_ERROR,
+          test, "an expansion that nests without end is an error");
+    check(strstr(contextErrorMessage(context), "nests too deeply") != NULL, test, "the nesting error says so");
+    check(expander.depth == 0 && expander.elementCount == 0, test, "an error leaves no expansion state behind");
+
+    expandText(&expander, "(defmacro twice (x) (list x x))");
+    check(contextExpandForm(&expander, parseText(context, "(twice)"), &expanded) == CONTEXT_MACRO_ERROR,
+          test, "too few arguments is an error");
+    check(isSameTree(expandText(&expander, "(f (twice a))"), parseText(context, "(f (list a a))")),
+          test, "the expander still works after errors");
+
+    freeExpander(&expander);
+    destroyContext(context);
+}
+
+void testLongExpansion()
+{
+    const char *test = "longExpansion";
+    struct Context *context = createContext();
+    struct Expander expander = createExpander(context);
+
+    expandText(&expander, "(defmacro twice (x) (list x x))");
+
+    // More elements than the scratch stack starts with, at several levels
+    char text[64 * 1024];
+    char expected[64 * 1024];
+    int length = sprintf(text, "(top");
+    int expectedLength = sprintf(expected, "(top");
+
+    for (int i = 0; i < 2000; i++)
+    {
+        length += sprintf(text + length, i % 100 == 0 ? " (twice (twice %d))" : " (twice %d)", i);
+        expectedLength += sprintf(expected + expectedLength, i % 100 == 0 ? " (list (list %d %d) (list %d %d))" : " (list %d %d)", i, i, i, i);
+    }
+
+    sprintf(text + length, ")");
+    sprintf(expected + expectedLength, ")");
+
+    check(isSameTree(expandText(&expander, text), parseText(context, expected)), test, "a long list expands element by element");
+    check(expander.elementCount == 0 && expander.elementCapacity >= 2000, test, "the scratch stack grows and is emptied");
+
+    freeExpander(&expander);
+    destroyContext(context);
+}
+
+void testMacrosAcrossEdits()
+{
+    const char *test = "macrosAcrossEdits";
+    struct Context *context = createContext();
+    struct Expander expander = createExpander(context);
+    struct Document document;
+    openDocument(context, strdup("(defmacro twice (x) (list x x))\n(twice a)"), &document);
+
+    struct SExpr *expanded;
+    contextExpandForm(&expander, document.forms[0].sexpr, &expanded);
+
+    // Renaming the parameter frees the defining form; the macro keeps its copy
+    editDocument(&document, 17, 1, "y");
+    editDocument(&document, 26, 3, "y y");
+    if (document.formCount != 2 || strcmp(document.scanner.source, "(defmacro twice (y) (list y y))\n(twice a)") != 0)
+    {
+        check(false, test, "the definition is edited");
+        return;
+    }
+
+    contextExpandForm(&expander, document.forms[1].sexpr, &expanded);
+    check(isSameTree(expanded, parseText(context, "(list a a)")), test, "a macro outlives the form that defined it");
+
+    // Each edit frees the call and parses a new one, maybe at the same address
+    int staleCount = 0;
+    for (int i = 0; i < 50; i++)
+    {
+        char argument[16];
+        char expected[64];
+        sprintf(argument, "a%d", i);
+        sprintf(expected, "(list %s %s)", argument, argument);
+
+        int callStart = strlen("(defmacro twice (y) (list y y))\n(twice ");
+        editDocument(&document, callStart, strchr(document.scanner.source + callStart, ')') - document.scanner.source - callStart, argument);
+
+        contextExpandForm(&expander, document.forms[1].sexpr, &expanded);
+        staleCount += !isSameTree(expanded, parseText(context, expected));
+    }
+
+    check(staleCount == 0, test, "expansions of edited forms are never stale");
+
+    closeDocument(&document);
+    freeExpander(&expander);
+    destroyContext(context);
+}
+
+// Context Related
+// Statuses contextNextForm returns for text, one per call up to CONTEXT_END
+bool nextFormStatusesAre(const char *text, const int *statuses, int statusCount)
+{
+    struct Context *context = createContext();
+    contextParse(context, text, strlen(text));
+
+    bool isMatching = true;
+    for (int i = 0; i < statusCount; i++)
+    {
+        struct SExpr *form;
+        isMatching = isMatching && contextNextForm(context, &form) == statuses[i];
+    }
+
+    destroyContext(context);
+
+    return isMatching;
+}
+
+void testNextFormAfterErrors()
+{
+    const char *test = "nextFormAfterErrors";
+
+    int malformed[] = {CONTEXT_OK, CONTEXT_PARSE_ERROR, CONTEXT_OK, CONTEXT_PARSE_ERROR, CONTEXT_END};
+    check(nextFormStatusesAre("(a) (b . ) c (d) (e", malformed, 5), test, "forms after a parse error are still read");
+
+    int stray[] = {CONTEXT_OK, CONTEXT_SCAN_ERROR, CONTEXT_OK, CONTEXT_END, CONTEXT_END};
+    check(nextFormStatusesAre("(a) ) (b)", stray, 5), test, "a stray closer is skipped");
+
+    struct Context *context = createContext();
+    const char *text = "(a $ b) (c)";
+    check(contextParse(context, text, strlen(text)) == CONTEXT_SCAN_ERROR, test, "a bad character is a scan error");
+    check(strlen(contextErrorMessage(context)) > 0, test, "the scan error has a message");
+
+    struct SExpr *form;
+    check(contextNextForm(context, &form) == CONTEXT_OK && isSameTree(form, listNth(parseText(context, "((a b))"), 0)),
+          test, "the form around a bad character is still read");
+
+    // Forms stay valid after the next buffer and after their buffer is freed
+    char *buffer = strdup("(kept \"string\" 42)");
+    struct SExpr *kept = parseText(context, buffer);
+    free(buffer);
+    parseText(context, "(other)");
+    check(isSameTree(kept, parseText(context, "(kept \"string\" 42)")), test, "forms outlive their buffer");
+
+    destroyContext(context);
+}
+
+void testHashTables()
+{
+    const char *test = "hashTables";
+    struct Context *context = createContext();
+
+    struct SExpr *table;
+    check(contextHashTable(context, &table) == CONTEXT_OK && hashTableSize(table) == 0, test, "a new table is empty");
+
+    // Enough keys to resize the table a few times
+    for (int i = 0; i < 1000; i++)
+    {
+        contextHashTablePut(context, table, integer(context, i), integer(context, i * 2));
+    }
+    contextHashTablePut(context, table, string(context, "name"), symbol(context, "first"));
+    contextHashTablePut(context, table, string(context, "name"), symbol(context, "second"));
+
+    check(hashTableSize(table) == 1001, test, "putting a key again replaces its value");
+    check(hashTableGet(table, string(context, "name")) == symbol(context, "second"), test, "strings are keys by content");
+    check(hashTableGet(table, integer(context, 500))->integer == 1000, test, "integer keys are found after resizing");
+    check(hashTableGet(table, symbol(context, "missing")) == NULL, test, "a missing key has no value");
+
+    check(hashTableRemove(table, integer(context, 0)) && !hashTableRemove(table, integer(context, 0)), test, "a key is removed once");
+    check(hashTableGet(table, integer(context, 0)) == NULL && hashTableSize(table) == 1000, test, "a removed key is gone");
+
+    // Iteration follows insertion order and skips removed keys
+    int position = 0;
+    int expectedKey = 1;
+    bool isInOrder = true;
+    struct SExpr *key;
+    struct SExpr *value;
+
+    while (hashTableNext(table, &position, &key, &value) && key->type == TYPE_INTEGER)
+    {
+        isInOrder = isInOrder && key->integer == expectedKey++;
+    }
+
+    check(isInOrder && expectedKey == 1000 && key->type == TYPE_STRING, test, "iteration follows insertion order");
+
+    destroyContext(context);
+}
+
+int main()
+{
+    testEditsMatchFreshParse();
+    testInvalidEdit();
+    testEmptyDocument();
+    testMalformedForm();
+    testExpansionCache();
+    testRedefinition();
+    testMacroErrors();
+    testLongExpansion();
+    testMacrosAcrossEdits();
+    testNextFormAfterErrors();
+    testHashTables();
+
+    printf("Passed %d out of %d API checks\n", checkCount - failureCount, checkCount);
+
+    return failureCount > 0;
+}